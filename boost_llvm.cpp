@@ -1,13 +1,20 @@
+#include <array>
+#include <atomic>
 #include <boost/operators.hpp>
 #include <cstddef>
 #include "details.hpp"
 #include <functional>
+#include <future>
 #include <iosfwd>
+#include <memory>
+#include <mutex>
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 namespace llvm
 {
+  class LLVMContext;
   class Module;
   class Type;
   class Value;
@@ -18,6 +25,37 @@ namespace boost { namespace llvm
   class value;
   class ref;
 
+  // ================================================================================
+  // Contexts.
+  //
+  // Owns an LLVMContext.  Ownership is shared: every module created in a
+  // context holds a reference to it, so the context lives as long as its last
+  // module or scope.  Types, values and modules belong to the context that was
+  // current when they were created and must not be mixed with those of
+  // another.
+  //
+  // Each thread has its own scope stack, and so its own current context, which
+  // lets threads build and optimize modules concurrently without a global
+  // lock.  A thread that never makes a context current gets a private default
+  // context on first use, so single-threaded code need not mention contexts.
+  // A context must be used by one thread at a time; code that may share one
+  // with another thread (e.g., with a jit) must hold its lock.
+  // ================================================================================
+  class context
+  {
+    context();
+  public:
+    static std::shared_ptr<context> make();
+    context(context const &) = delete;
+    context & operator=(context const &) = delete;
+    static std::shared_ptr<context> current(); // per-thread; never null
+    std::unique_lock<std::mutex> lock();
+
+    // Access to LLVM.
+    ::llvm::LLVMContext * ptr() const;
+    explicit operator ::llvm::LLVMContext *() const;
+  };
+
   // ================================================================================
   // Types.
   // ================================================================================
@@ -52,7 +90,7 @@ namespace boost { namespace llvm
     template<typename... Types, BOOST_LLVM_ENABLE_IF_TYPE_SEQUENCE(Types)>
       type operator()(Types &&...) const;
 
-    // From-host type creator.
+    // From-host type creator.  The result is cached per context.
     template<typename T> static type get()
     {
       using U = typename std::remove_reference<T>::type;
@@ -60,7 +98,39 @@ namespace boost { namespace llvm
       return get_impl<V>();
     }
 
+    // Checks that the LLVM layout of a host type (size, alignment and the
+    // offsets of tuple members, including tuples nested in tuples and arrays)
+    // matches the host compiler's.  If so, compiled code may access host
+    // objects of that type in place, through a pointer.  Only triviality is
+    // checked at compile time.  The layout comparison depends on the current
+    // module's data layout, so it is made at run time and the caller must
+    // check the result, typically once at startup.
+    //
+    // get<std::tuple<...>> lays members out in declaration order.  libstdc++
+    // stores tuple members in reverse, so with it no tuple of two or more
+    // members passes, and in-place access is limited to scalars, arrays of
+    // them and single-member tuples.
+    template<typename T> static bool has_host_layout()
+    {
+      static_assert(
+          !std::is_array<T>::value || std::extent<T>::value != 0
+        , "the array extent is required"
+        );
+      static_assert(
+          detail::is_host_accessible<T>::value
+        , "only trivially copyable host types can be accessed in place"
+        );
+      return check_layout(
+          get<T>(), sizeof(T), alignof(T), detail::host_offsets<T>::get()
+        );
+    }
+
   private:
+    // offsets as computed by detail::host_offsets.
+    static bool check_layout(
+        type, size_t size, size_t align, array_ref<size_t> offsets
+      );
+
     template<typename T> struct get_impl // scalar
       { explicit operator type() const; };
     template<typename T> struct get_impl<T*> // pointer
@@ -95,6 +165,13 @@ namespace boost { namespace llvm
     value operator()(string_ref);
     template<typename...Ts> value operator()(std::tuple<Ts...> const &);
     value operator()(array_ref<value> const &);
+    // Packed constant data, created in one step from a contiguous buffer.  T
+    // is not deduced through conversions, so pass a std::vector as
+    // array_ref<T>(vec).
+    template<typename T, BOOST_LLVM_ENABLE_IF(std::is_arithmetic<T>)>
+      value operator()(array_ref<T> const &);
+    template<typename T, BOOST_LLVM_ENABLE_IF(std::is_arithmetic<T>)>
+      value operator()(T const *, size_t);
     template<typename T> value operator()(BOOST_LLVM_INIT_LIST_1D(T));
     template<typename T> value operator()(BOOST_LLVM_INIT_LIST_2D(T));
     template<typename T> value operator()(BOOST_LLVM_INIT_LIST_3D(T));
@@ -145,6 +222,11 @@ namespace boost { namespace llvm
     template<typename T> value(BOOST_LLVM_INIT_LIST_7D(T));
     template<typename T> value(BOOST_LLVM_INIT_LIST_8D(T));
     template<typename T> value(BOOST_LLVM_INIT_LIST_9D(T));
+    // Packed constant data; see type::operator()(array_ref<T> const &).
+    template<typename T, BOOST_LLVM_ENABLE_IF(std::is_arithmetic<T>)>
+      value(array_ref<T> const &);
+    template<typename T, BOOST_LLVM_ENABLE_IF(std::is_arithmetic<T>)>
+      value(T const *, size_t);
 
     // Accessors.
     value operator[](value) const;
@@ -195,6 +277,16 @@ namespace boost { namespace llvm
   // note: most operators are acquired via conversion to value.
   struct initializer { explicit initializer(value); };
 
+  // Memory access modes for load_with and store_with.
+  struct access
+  {
+    size_t align = 0; // known alignment in bytes; zero means the ABI alignment
+    bool nontemporal = false; // streaming access; bypasses the cache
+    bool invariant = false; // loads only: the memory does not change
+    bool atomic = false; // if set, the access is atomic with the given order
+    std::memory_order order = std::memory_order_seq_cst;
+  };
+
   class const_ref
   {
     const_ref() {}
@@ -205,6 +297,8 @@ namespace boost { namespace llvm
 
     // Load.
     explicit operator value() const; // emits a load instruction.
+    value load(std::memory_order) const; // emits an atomic load.
+    value load_with(access const &) const;
 
     // Address of.
     value operator&() const;
@@ -228,6 +322,28 @@ namespace boost { namespace llvm
 
     // Store.
     ref & operator=(value) const; // emits a store instruction.
+    ref & store(value, std::memory_order) const; // emits an atomic store.
+    ref & store_with(value, access const &) const;
+
+    // Atomic read-modify-write.  Each returns the previous value.
+    value fetch_add(value, std::memory_order=std::memory_order_seq_cst) const;
+    value fetch_sub(value, std::memory_order=std::memory_order_seq_cst) const;
+    value fetch_and(value, std::memory_order=std::memory_order_seq_cst) const;
+    value fetch_or(value, std::memory_order=std::memory_order_seq_cst) const;
+    value fetch_xor(value, std::memory_order=std::memory_order_seq_cst) const;
+    value exchange(value, std::memory_order=std::memory_order_seq_cst) const;
+    // Returns a {T, bool} pair: the previous value and whether the exchange
+    // took place.  As for std::atomic, a single order also determines the
+    // failure order: acq_rel becomes acquire, release becomes relaxed, and
+    // any other order is used as is.
+    value compare_exchange(
+        value expected, value desired
+      , std::memory_order=std::memory_order_seq_cst
+      ) const;
+    value compare_exchange(
+        value expected, value desired
+      , std::memory_order success, std::memory_order failure
+      ) const;
 
     // Accessors.
     ref operator[](value) const;
@@ -255,6 +371,14 @@ namespace boost { namespace llvm
     ref & operator=(initializer) const;
   };
 
+  // Memory fence.
+  value fence(std::memory_order);
+
+  // Software prefetch.  Locality ranges from 0 (none) to 3 (keep in all cache
+  // levels).
+  value prefetch(const_ref, bool write=false, int locality=3);
+  value prefetch(value address, bool write=false, int locality=3);
+
 
   // ================================================================================
   // Intrinsics.
@@ -271,6 +395,46 @@ namespace boost { namespace llvm
   value offsetof_(type, string_ref);
 
 
+  // ================================================================================
+  // Intrinsic functions.
+  //
+  // Each lowers directly to an LLVM intrinsic.  Where a signed and an unsigned
+  // form exist, the operand type selects between them.  As with sizeof_, the
+  // trailing underscore keeps these from capturing unqualified calls to the
+  // host functions of the same name, since value converts from any
+  // arithmetic type.
+  // ================================================================================
+  // Math.
+  value fma_(value, value, value);
+  value sqrt_(value);
+  value min_(value, value);
+  value max_(value, value);
+  value abs_(value);
+
+  // Bit manipulation.
+  value ctpop_(value);
+  value ctlz_(value);
+  value cttz_(value);
+  value bswap_(value);
+  value rotl_(value, value);
+  value rotr_(value, value);
+
+  // Overflow-checked arithmetic.  The result is a {T, bool} pair; use dot(0)
+  // for the value and dot(1) for the overflow flag.
+  value add_overflow_(value, value);
+  value sub_overflow_(value, value);
+  value mul_overflow_(value, value);
+
+  // Saturating arithmetic.
+  value add_sat_(value, value);
+  value sub_sat_(value, value);
+
+  // Memory.  The size is in bytes.
+  value memcpy_(ref dst, const_ref src, value size);
+  value memmove_(ref dst, const_ref src, value size);
+  value memset_(ref dst, value byte, value size);
+
+
   // ================================================================================
   // Casts.
   //
@@ -280,31 +444,286 @@ namespace boost { namespace llvm
   value static_cast_(type, value);
 
 
+  // ================================================================================
+  // Vectors.
+  //
+  // Operations on values of vector type (see type::operator*(type, size_t)).
+  // Each lowers to the corresponding LLVM vector instruction or intrinsic.
+  // ================================================================================
+  // Lane access.
+  value extract(value vec, value lane);
+  value insert(value vec, value lane, value elem);
+
+  // Permutation.  A negative index produces an undefined lane.
+  value shuffle(value, value, array_ref<int> mask);
+  value splat(value, size_t lanes);
+
+  // Horizontal reductions.
+  value reduce_add(value);
+  value reduce_mul(value);
+  value reduce_and(value);
+  value reduce_or(value);
+  value reduce_xor(value);
+  value reduce_min(value);
+  value reduce_max(value);
+
+  // Masked memory access.  Masked-off lanes of a load take the value in
+  // passthru.
+  value masked_load(value ptr, value mask, value passthru);
+  value masked_store(value vec, value ptr, value mask);
+  value gather(value ptrs, value mask, value passthru);
+  value scatter(value vec, value ptrs, value mask);
+
+  // Lane-wise (or scalar) selection.
+  value select(value cond, value, value);
+
+
   // ================================================================================
   // Modules.
   // ================================================================================
+  // The CPU and features to generate code for.
+  class target
+  {
+  public:
+    target(); // the default triple with a generic CPU
+    explicit target(
+        string_ref cpu, string_refs const & features = string_refs()
+      );
+    static target native(); // the host CPU and its features
+
+    // x86-64 ISA levels.
+    static target x86_64_v2(); // SSE4.2
+    static target x86_64_v3(); // AVX2
+    static target x86_64_v4(); // AVX-512
+  };
+
+  // An optimization pass pipeline, in the textual syntax of the LLVM pass
+  // manager; e.g., "function(sroa,instcombine)".
+  class pipeline
+  {
+  public:
+    explicit pipeline(string_ref passes);
+    static pipeline preset(int level); // as for module::optimize(int)
+    pipeline & add(string_ref pass);
+    pipeline & remove(string_ref pass);
+  };
+
+  // Wall time and change in IR size of each pass run by module::optimize.
+  struct optimization_report
+  {
+    struct pass
+    {
+      std::string name;
+      double seconds = 0;
+      ptrdiff_t instructions_delta = 0;
+    };
+    std::vector<pass> passes;
+    double seconds = 0;
+  };
+
+  // Content-addressed on-disk cache of machine code.  Entries are keyed by the
+  // module bitcode hash, target triple, CPU, feature set and optimization
+  // level.
+  class object_cache
+  {
+  public:
+    object_cache(std::string const & directory);
+  };
+
+  // Counts and cycle totals gathered by an instrumented module.  Counters are
+  // per-thread; a report sums over all threads.
+  struct hot_path_report
+  {
+    struct loop // one per for_, while_ or do_, in order of creation
+    {
+      std::string name; // loop_hints::name, or "loop<N>" with N the position
+      uint64_t iterations = 0;
+      uint64_t cycles = 0;
+    };
+    struct function
+    {
+      std::string name;
+      uint64_t calls = 0;
+      uint64_t cycles = 0; // TSC ticks from entry to exit
+      std::vector<loop> loops;
+    };
+    std::vector<function> functions;
+  };
+
+  // Code generation statistics for a module.  Collection is off by default and
+  // costs one branch per event when disabled.
+  struct build_statistics
+  {
+    // Instructions emitted, indexed by llvm::Instruction opcode.  The
+    // implementation static_asserts that every opcode is below the limit.
+    static size_t constexpr opcode_limit = 128;
+    std::array<size_t, opcode_limit> instructions = {{}};
+    size_t blocks = 0;
+    size_t labels = 0;
+    // Constants and types newly interned in the context while building this
+    // module.  Those the context already held (e.g., cached by type::get, or
+    // created for another module) are not counted again.
+    size_t constants = 0;
+    size_t types = 0;
+    double build_seconds = 0;
+    double optimize_seconds = 0;
+    double compile_seconds = 0;
+  };
+
+  class jit;
+
   class module
   {
   public:
-    module(string_ref name);
-    module(::llvm::Module *);
+    enum LinkMode { LINK_ALL, LINK_ONLY_NEEDED };
+
+    module(string_ref name); // in the current context
+    // Adopts an existing LLVM module, which must belong to the given context.
+    module(
+        ::llvm::Module *
+      , std::shared_ptr<context> const & = context::current()
+      );
+    module(module &&);
+    module & operator=(module &&);
 
     // I/O
-    static module && read(std::string const & filename);
-    static module && read(std::istream & stream);
+    //
+    // Reading is lazy: function bodies are materialized on first reference by
+    // compile or link.  optimize and write materialize everything first, since
+    // they need every body.  A file is memory-mapped.  A stream cannot be, so
+    // it is read into memory in full; only materialization is deferred.
+    static module read(std::string const & filename);
+    static module read(std::istream & stream);
+    module & materialize(); // materializes all remaining function bodies
     void write(std::string const & filename, bool binary=true);
     void write(std::ostream & stream, bool binary=true);
 
     // Build.
-    module & link(module &);
+    // The linked modules must share this module's context and are consumed:
+    // their definitions are moved here and they are left empty.  With
+    // LINK_ONLY_NEEDED, only definitions transitively referenced from this
+    // module are imported.  Linking several modules in one call computes the
+    // needed set once over all of them.
+    module & link(module &, LinkMode=LINK_ALL);
+    module & link(array_ref<module *>, LinkMode=LINK_ALL);
     module & optimize(int level); // 0, 1, 2, 3, 's', 'z'.
+    // Also sets the module's target triple, data layout and CPU features.
+    // These persist and apply to every later optimize and compile call.
+    module & optimize(int level, target const &);
+    module & optimize(pipeline const &, optimization_report * = nullptr);
+    // Optimizes several modules without merging them, ThinLTO style.  A summary
+    // is built for each module, and each module is then written as bitcode and
+    // reloaded into a private context on a worker thread, so modules may share
+    // a context.  There it imports the callees worth inlining from the others
+    // and is optimized independently, in parallel.  Each result is then read
+    // back into its module's original context and replaces its contents, so
+    // modules that shared a context can still be linked.  Any value, ref or
+    // label held into the old contents is invalidated; types, which belong to
+    // the context, are not.  A callee is imported if its size in instructions
+    // is below import_threshold, scaled up for hot call sites.  Without profile
+    // data (see compile_profiled), call-site hotness is estimated from static
+    // block frequencies.
+    static void optimize(
+        array_ref<module *>, int level, size_t import_threshold=100
+      );
     template<typename F> std::function<F> compile(string_ref);
 
+    // Tiered compilation.  Returns immediately with code built at -O0.  After
+    // the function has been called hot_threshold times, it is recompiled at
+    // the given level on a background thread and the entry point is swapped
+    // atomically.  Calls in flight finish on the old code.  The module is
+    // cloned into a private context for the background thread at the time of
+    // the call, so it may be modified or destroyed afterward.
+    template<typename F> std::function<F> compile_tiered(
+        string_ref, int level=3, size_t hot_threshold=1000
+      );
+
+    // Profile-guided compilation.  The code is first built with edge and
+    // value-site counters.  After warmup calls, the module is re-optimized at
+    // the given level using the collected counts as branch weights and
+    // inlining hints, and the entry point is swapped as for compile_tiered.
+    // As there, the module is cloned at the time of the call.
+    template<typename F> std::function<F> compile_profiled(
+        string_ref, int level=3, size_t warmup=10000
+      );
+
+    // Batch compilation.  Materializes every named symbol in one backend pass
+    // on a worker thread.  Each future yields a plain function pointer, so
+    // calls carry no std::function overhead.  The module is cloned into a
+    // private context for the worker at the time of the call, so it may be
+    // modified or destroyed while compilation proceeds.  The compiled code is
+    // added to the given jit, which owns it; the pointers stay valid until
+    // the jit is destroyed.
+    template<typename... Fs>
+      std::tuple<std::future<Fs *>...> compile_async(
+          jit &, std::array<string_ref, sizeof...(Fs)> const &
+        );
+
+    // Object emission.  A copy of the module is optimized at the given level
+    // and lowered to machine code for the target; the module itself is left
+    // unchanged.  With a cache, this happens only on a miss and a hit loads
+    // the object directly, so later calls see the same module either way.
+    void emit_object(
+        std::ostream & stream, int level=2, target const & = target()
+      );
+    void emit_object(
+        std::ostream & stream, int level, target const &, object_cache &
+      );
+    template<typename F> std::function<F> compile(
+        string_ref, int level, target const &, object_cache &
+      );
+
+    // Instrumentation.  When enabled, code generated afterwards counts and
+    // times each function entry and exit and each loop back edge.
+    module & instrument(bool enable=true);
+    hot_path_report report() const;
+    void reset_report();
+
+    // Statistics.
+    module & collect_statistics(bool enable=true);
+    build_statistics const & statistics() const;
+
+    // The context that owns this module.
+    std::shared_ptr<context> const & get_context() const;
+
     // Access to LLVM.
     ::llvm::Module * ptr() const;
     explicit operator ::llvm::Module *() const;
   };
 
+  // A JIT session shared between threads.  An added module keeps its context
+  // alive, so modules built on different threads can be linked against one
+  // another here after their builders are gone.  The jit holds a module's
+  // context lock while compiling from it.
+  class jit
+  {
+  public:
+    jit();
+    jit & add(module &&);
+    template<typename F> std::function<F> compile(string_ref);
+  };
+
+  // Registration of JIT-compiled objects with profilers and debuggers.
+  //
+  // The EDSL records no source locations for the code that builds it, so line
+  // information refers instead to the textual IR of each module.  The IR is
+  // written to <ir_directory>/<module name>-<pid>-<n>.ll each time a module
+  // is compiled, where n counts compilations in the process.  Each compiled
+  // object thus has its own file, even for modules of the same name and for
+  // the recompiles of compile_tiered and compile_profiled, and perf and GDB
+  // report lines in that file.
+  struct jit_listeners
+  {
+    enum Kind { NONE=0, PERF_MAP=1, PERF_JITDUMP=2, GDB=4 };
+    // PERF_MAP writes /tmp/perf-<pid>.map; PERF_JITDUMP writes a jitdump file
+    // for "perf inject --jit"; GDB uses the GDB JIT interface.  The selection
+    // replaces the previous one and applies to compilations that start after
+    // the call; enable(NONE) turns registration off.  Objects already
+    // registered stay registered until their code is freed.  Safe to call
+    // from any thread.
+    static void enable(unsigned kinds, std::string const & ir_directory="/tmp");
+  };
+
 
   // ================================================================================
   // Labels.
@@ -323,12 +742,18 @@ namespace boost { namespace llvm
   // Scopes.
   //
   // Defines where to insert symbols and instructions.  Manages a symbol table
-  // containing local variable names.
+  // containing local variable names.  The scope stack is per-thread.
+  //
+  // Names are interned per context and looked up by hash.  Each scope pushes a
+  // level of the symbol table on construction and pops it on destruction, so
+  // nested lexical scopes shadow outer names without copying them.
   // ================================================================================
   class scope
   {
   public:
-    scope(module const &);
+    scope(); // nested lexical scope at the current insertion point
+    scope(std::shared_ptr<context>); // makes the context current
+    scope(module const &); // also makes the module's context current
     scope(value const &); // the value must be a function
     scope(label const &);
     static module const * current_module();
@@ -345,6 +770,25 @@ namespace boost { namespace llvm
   // When called, generates code that produces the loop test value.
   using loop_test = std::function<value()>;
 
+  // When called, generates the loop body for the given induction value.  It is
+  // passed by const reference, since value cannot be copied or moved.
+  using loop_body = std::function<void(value const &)>;
+
+  // Loop metadata (llvm.loop).  Zero leaves the choice to the optimizer.
+  struct loop_hints
+  {
+    size_t vectorize_width = 0;
+    size_t interleave_count = 0;
+    size_t unroll_count = 0;
+    bool must_progress = false;
+    bool no_alias = false; // iterations do not alias (parallel_accesses)
+    // Identifies the loop in reports (see module::instrument).
+    string_ref name = string_ref();
+    // Branch weights on the loop test; both zero for none.
+    uint32_t continue_weight = 0;
+    uint32_t exit_weight = 0;
+  };
+
   // An argument that can be either a label or thunk.
   struct code
   {
@@ -354,19 +798,61 @@ namespace boost { namespace llvm
     code(thunk=thunk());
   };
 
+  // Branch probabilities.  likely and unlikely annotate a condition (e.g., for
+  // if_ or a loop test) via llvm.expect; branch_weights gives explicit counts.
+  value likely(value);
+  value unlikely(value);
+  struct branch_weights
+  {
+    branch_weights(uint32_t taken, uint32_t not_taken);
+  };
+
   value if_(value, code, code=code());
+  value if_(value, code, branch_weights); // no else branch
+  value if_(value, code, code, branch_weights);
   value do_(code, loop_test);
   value while_(loop_test, code);
   value for_(code init, loop_test test, code step, code body);
+  value do_(code, loop_test, loop_hints const &);
+  value while_(loop_test, code, loop_hints const &);
+  value for_(
+      code init, loop_test test, code step, code body, loop_hints const &
+    );
+  // The body is outlined into a function, and the range [begin, end) is run
+  // across a work-stealing thread pool at runtime.  begin and end must have
+  // the same integer type, which is also the type of the induction value.
+  //
+  // The body may use values, refs and locals of the enclosing function; the
+  // outliner captures them.  Values are passed to the outlined function as
+  // arguments.  Locals and refs are passed by address, so stores through them
+  // are seen by the caller after the loop.  They are not synchronized, so
+  // iterations must not write the same location except atomically.
+  //
+  // Returns the call into the runtime, which returns once every iteration has
+  // completed.
+  value parallel_for_(value begin, value end, loop_body);
   value goto_(label);
   value goto_(value, array_ref<label>); // computed goto
   struct switch_
   {
     switch_(value);
     switch_ & case_(int64_t, label);
+    switch_ & case_(int64_t, label, uint32_t weight);
+    switch_ & case_(array_ref<std::pair<int64_t, label>>); // bulk
+    switch_ & case_( // bulk, weighted
+        array_ref<std::tuple<int64_t, label, uint32_t>>
+      );
     switch_ && default_(label);
+    switch_ && default_(label, uint32_t weight);
     explicit operator value() const;
   };
+  // Direct-threaded dispatch.  Holds a table of handler addresses; each call
+  // emits its own indirectbr, so every handler gets a separate dispatch point.
+  struct dispatch_table
+  {
+    dispatch_table(array_ref<label> handlers);
+    value operator()(value index) const; // jumps to handlers[index]
+  };
   value break_();
   value continue_();
   value return_();
@@ -390,15 +876,50 @@ namespace boost { namespace llvm
   ref static_(type, symbol_name, string_refs, code=code());
   ref inline_(type, symbol_name, string_refs, code=code());
 
+  // Clone a function once per target and replace it with a resolver.  On first
+  // call, the resolver tries the targets in the order given (so list the most
+  // capable first) and binds the first one the running CPU supports.  If none
+  // is supported, it binds the original function, built for the module's
+  // target, which is always kept as the fallback.
+  ref multiversion(ref, array_ref<target>);
+
+  // Function attributes.  Each applies to a function created above and returns
+  // it, so they can be chained; e.g., cold(noinline(static_(...))).
+  ref hot(ref);
+  ref cold(ref);
+  ref noinline(ref);
+  ref alwaysinline(ref);
+
+  // Parameter attributes.  The parameter is identified by name or by its
+  // zero-based position; names are optional in extern_ and friends.
+  ref noalias(ref, string_ref param);
+  ref noalias(ref, size_t param);
+  ref readonly(ref, string_ref param);
+  ref readonly(ref, size_t param);
+  ref nonnull(ref, string_ref param);
+  ref nonnull(ref, size_t param);
+  ref align(ref, string_ref param, size_t bytes);
+  ref align(ref, size_t param, size_t bytes);
+
   // Create global variables.
   ref extern_(type, symbol_name);
   ref static_(type, symbol_name);
+  // Create a read-only global variable bound to host memory.  The data is not
+  // copied; the buffer must outlive any code compiled against it.  Like the
+  // packed constants, this is limited to arithmetic elements, whose layout
+  // needs no check (see type::has_host_layout).
+  template<typename T, BOOST_LLVM_ENABLE_IF(std::is_arithmetic<T>)>
+    const_ref extern_(array_ref<T> const &, symbol_name);
 
 
   // ================================================================================
   // Variable access.
   //
   // If a name is provided, then "var" can be used to locate a variable.
+  //
+  // Stack variables are always allocated in the entry block of the current
+  // function, even inside loop bodies, so that they can be promoted to
+  // registers.  Lifetime markers bound each one to the enclosing scope.
   // ================================================================================
   // Allocate a stack variable with optional name.
   ref local(type, string_ref = string_ref());
@@ -461,9 +982,10 @@ namespace boost { namespace llvm
     string_iterator begin() const;
     string_iterator end() const;
     size_t size() const;
-    std::string const & operator[](size_t) const;
+    string_ref operator[](size_t) const; // refers to the interned name
   };
-  // Lookup the named local variable or function parameter.
+  // Lookup the named local variable or function parameter, innermost scope
+  // first.
   ref var(string_ref);
 
 
@@ -2,6 +2,9 @@
 #include <type_traits>
 #include <initializer_list>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "array_ref.hpp"
@@ -76,6 +79,89 @@ namespace boost { namespace llvm { namespace detail
   using disable_for_typed_sequence = disabler<
       is_typed_sequence<Target, Types...>
     >;
+
+  // The type whose members are checked for a host type: cv-qualifiers and
+  // array extents are stripped.
+  template<typename T>
+  using host_element_t = typename std::remove_cv<
+      typename std::remove_all_extents<T>::type
+    >::type;
+
+  template<typename T>
+  struct is_host_accessible_impl : std::is_trivially_copyable<T> {};
+
+  // Whether host objects of type T may be accessed in place by compiled code.
+  // std::tuple is not trivially copyable under every standard library (its
+  // assignment is user-provided), so tuples are judged by their members.
+  template<typename T>
+  struct is_host_accessible : is_host_accessible_impl<host_element_t<T>> {};
+
+  // True if every member is (the sequences match only when all are true).
+  template<typename... Ts>
+  struct is_host_accessible_impl<std::tuple<Ts...>>
+    : std::is_same<
+          std::integer_sequence<bool, true, is_host_accessible<Ts>::value...>
+        , std::integer_sequence<bool, is_host_accessible<Ts>::value..., true>
+        >
+  {};
+
+  template<typename T>
+  struct host_offsets_impl // scalar
+  {
+    static void append(std::vector<size_t> & out, size_t base)
+      { out.push_back(base); }
+  };
+
+  // Byte offsets of the scalar members of a host type, in declaration order,
+  // as laid out by the host compiler.  Nested tuples are flattened.  An array
+  // contributes the offsets of its first element, since every element is laid
+  // out alike.  A scalar has the single offset zero.
+  template<typename T>
+  struct host_offsets
+  {
+    static std::vector<size_t> get()
+    {
+      std::vector<size_t> out;
+      append(out, 0);
+      return out;
+    }
+
+    static void append(std::vector<size_t> & out, size_t base)
+      { host_offsets_impl<host_element_t<T>>::append(out, base); }
+  };
+
+  template<typename... Ts>
+  struct host_offsets_impl<std::tuple<Ts...>>
+  {
+    static void append(std::vector<size_t> & out, size_t base)
+      { append(out, base, std::index_sequence_for<Ts...>()); }
+
+  private:
+    template<size_t... Is>
+    static void append(
+        std::vector<size_t> & out, size_t base, std::index_sequence<Is...>
+      )
+    {
+      using tuple_t = std::tuple<Ts...>;
+      static_assert(
+          std::is_default_constructible<tuple_t>::value
+        , "checking a tuple layout requires default-constructible members"
+        );
+      // A real object, so that std::get is valid.  The members are trivial,
+      // so this is cheap.
+      tuple_t const t{};
+      char const * const start = reinterpret_cast<char const *>(&t);
+      int const expand[] = {0, (
+          host_offsets<Ts>::append(
+              out
+            , base + static_cast<size_t>(
+                  reinterpret_cast<char const *>(&std::get<Is>(t)) - start
+                )
+            )
+        , 0)...};
+      (void) expand;
+    }
+  };
 }}}
 
 